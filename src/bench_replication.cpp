@@ -0,0 +1,241 @@
+#include "./generated/dateisystem.pb.h"
+#include "replication.h"
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <google/protobuf/arena.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <new>
+
+// Benchmark für den Replikationspfad. Der neue Pfad ruft dieselben Funktionen
+// aus replication.h auf wie der Server (SyncFile, ReplicateEntry, GetUpdates);
+// der alte Pfad bildet den Stand vor der Umstellung nach (jede Stufe kopiert
+// den LogEntry, pro Peer eine eigene Serialisierung).
+//
+// Phasen: write = Master (Request parsen, Eintrag anlegen, an alle Peers
+// serialisieren), receive = ein Peer (Eintrag parsen, puffern, loggen),
+// updates = GetUpdates-Antwort. (De-)Serialisierung läuft wie im Server
+// über grpc::SerializationTraits bzw. ByteBuffer.
+//
+// Gemessen werden Heap-Allokationen (Anzahl und allokierte Bytes), keine
+// memcpy-Aufrufe. Da jede Payload-Kopie eine Allokation gleicher Größe
+// braucht, sind die allokierten Bytes eine Obergrenze für kopierte Payloads.
+//
+// Aufruf: ./bench_replication [payload_bytes] [writes] [peers]
+
+using namespace dateisystem;
+
+// Log-Länge für die GetUpdates-Messung
+static const int kUpdateEntries = 4;
+
+static std::atomic<size_t> g_allocs{0};
+static std::atomic<size_t> g_bytes{0};
+
+// Eigene Funktionen, damit der Compiler malloc/free nicht direkt gegen
+// new/delete abgleicht (-Wmismatched-new-delete)
+__attribute__((noinline)) static void* countedAlloc(size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(n, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) static void countedFree(void* p) { std::free(p); }
+
+void* operator new(size_t n) { return countedAlloc(n); }
+void* operator new[](size_t n) { return countedAlloc(n); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+
+struct Result { size_t allocs; size_t bytes; double ms; };
+
+// Alter Schreibpfad: SyncFile kopiert in entry und log, der Stub
+// serialisiert den Eintrag für jeden Peer neu
+static void writeCopy(const grpc::ByteBuffer& wire_req, int writes, int peers) {
+  for (int i = 1; i <= writes; ++i) {
+    std::vector<LogEntry> master_log;
+    SyncRequest req;
+    grpc::ByteBuffer in(wire_req);
+    grpc::SerializationTraits<SyncRequest>::Deserialize(&in, &req);
+    LogEntry entry;
+    entry.set_seq(i);
+    entry.set_file_path(req.file_path());
+    entry.set_file_content(req.file_content());
+    master_log.push_back(entry);
+    for (int p = 0; p < peers; ++p) {
+      grpc::ByteBuffer out;
+      bool own_buffer;
+      grpc::SerializationTraits<LogEntry>::Serialize(entry, &out, &own_buffer);
+    }
+  }
+}
+
+// Neuer Schreibpfad wie im Server: Request in der Arena des Aufrufs,
+// makeWriteEntry übernimmt den Inhalt, serializeEntry einmal für alle Peers
+static void writeShared(const grpc::ByteBuffer& wire_req, int writes, int peers) {
+  for (int i = 1; i <= writes; ++i) {
+    std::vector<EntryPtr> master_log;
+    ArenaPtr arena = newArena();
+    auto* req = google::protobuf::Arena::CreateMessage<SyncRequest>(arena.get());
+    grpc::ByteBuffer in(wire_req);
+    grpc::SerializationTraits<SyncRequest>::Deserialize(&in, req);
+    EntryPtr entry = makeWriteEntry(arena, req, i, 0);
+    master_log.push_back(entry);
+    grpc::ByteBuffer wire;
+    serializeEntry(*entry, &wire);
+    for (int p = 0; p < peers; ++p) {
+      grpc::ByteBuffer out(wire);  // teilt die Slices
+    }
+  }
+}
+
+// Alter Empfangspfad eines Peers: Kopie in buffer und log
+static void receiveCopy(const grpc::ByteBuffer& wire_entry, int calls) {
+  for (int i = 0; i < calls; ++i) {
+    LogEntry e;
+    grpc::ByteBuffer in(wire_entry);
+    grpc::SerializationTraits<LogEntry>::Deserialize(&in, &e);
+    std::map<int64_t, LogEntry> buffer;
+    std::vector<LogEntry> peer_log;
+    buffer[e.seq()] = e;
+    peer_log.push_back(buffer.begin()->second);
+  }
+}
+
+// Neuer Empfangspfad wie ReplicateEntry: Eintrag in der Arena, per adoptEntry geteilt
+static void receiveShared(const grpc::ByteBuffer& wire_entry, int calls) {
+  for (int i = 0; i < calls; ++i) {
+    ArenaPtr arena = newArena();
+    auto* e = google::protobuf::Arena::CreateMessage<LogEntry>(arena.get());
+    grpc::ByteBuffer in(wire_entry);
+    grpc::SerializationTraits<LogEntry>::Deserialize(&in, e);
+    std::map<int64_t, EntryPtr> buffer;
+    std::vector<EntryPtr> peer_log;
+    buffer[e->seq()] = adoptEntry(arena, e);
+    peer_log.push_back(std::move(buffer.begin()->second));
+  }
+}
+
+// Alter GetUpdates-Pfad: Deep-Copy jedes Eintrags in die Antwort
+static void updatesCopy(const std::vector<LogEntry>& log, int calls) {
+  for (int i = 0; i < calls; ++i) {
+    UpdateResponse resp;
+    for (auto& e : log) *resp.add_entries() = e;
+    std::string out = resp.SerializeAsString();
+  }
+}
+
+// Neuer GetUpdates-Pfad wie im Server: direkt aus den geteilten Einträgen
+// in einen Puffer (im Server ein grpc_slice) serialisieren
+static void updatesShared(const std::vector<EntryPtr>& log, int calls) {
+  for (int i = 0; i < calls; ++i) {
+    std::vector<EntryPtr> entries(log.begin(), log.end());
+    std::unique_ptr<uint8_t[]> out(new uint8_t[updatesWireSize(entries)]);
+    writeUpdates(entries, out.get());
+  }
+}
+
+template <typename F>
+static Result measure(F f) {
+  size_t a0 = g_allocs.load(), b0 = g_bytes.load();
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  auto t1 = std::chrono::steady_clock::now();
+  return { g_allocs.load() - a0, g_bytes.load() - b0,
+           std::chrono::duration<double, std::milli>(t1 - t0).count() };
+}
+
+static void print(const char* name, const Result& r, int ops) {
+  std::cout << std::left << std::setw(16) << name
+            << " allocs/op=" << std::setw(8) << r.allocs / ops
+            << " allokiert MiB/op=" << std::setw(10) << std::fixed << std::setprecision(2)
+            << r.bytes / double(ops) / (1 << 20)
+            << " ms=" << std::setprecision(1) << r.ms << "\n";
+}
+
+static void printSaving(const Result& copy, const Result& shared, int ops) {
+  long long saved = (static_cast<long long>(copy.bytes) -
+                     static_cast<long long>(shared.bytes)) / ops;
+  std::cout << "[Bench] eingesparte allokierte Bytes/op: " << saved << "\n";
+}
+
+// Liest eine nicht-negative Ganzzahl, false bei ungültiger Eingabe
+static bool parseArg(const char* s, long long& out) {
+  char* end = nullptr;
+  errno = 0;
+  out = std::strtoll(s, &end, 10);
+  return errno == 0 && end != s && *end == '\0' && out >= 0;
+}
+
+int main(int argc, char** argv) {
+  long long payload = 4 << 20, writes = 50, peers = 3;
+  if ((argc > 1 && !parseArg(argv[1], payload)) ||
+      (argc > 2 && !parseArg(argv[2], writes)) ||
+      (argc > 3 && !parseArg(argv[3], peers)) ||
+      writes < 1 || writes > 1000000 || peers > 1000) {
+    std::cerr << "Aufruf: " << argv[0] << " [payload_bytes] [writes>=1] [peers>=0]\n";
+    return 1;
+  }
+  int n = static_cast<int>(writes), np = static_cast<int>(peers);
+
+  SyncRequest proto;
+  proto.set_file_path("bench/file.bin");
+  proto.set_file_content(std::string(payload, 'x'));
+  grpc::ByteBuffer wire_req;
+  bool own_buffer;
+  grpc::SerializationTraits<SyncRequest>::Serialize(proto, &wire_req, &own_buffer);
+
+  std::cout << "[Bench] payload=" << payload << " B, writes=" << n
+            << ", peers=" << np << "\n";
+  Result wc = measure([&] { writeCopy(wire_req, n, np); });
+  Result ws = measure([&] { writeShared(wire_req, n, np); });
+  print("write copy", wc, n);
+  print("write shared", ws, n);
+  printSaving(wc, ws, n);
+
+  // Empfang bei einem Peer, writes * peers Aufrufe
+  if (np > 0) {
+    LogEntry sample;
+    sample.set_seq(1);
+    sample.set_file_path(proto.file_path());
+    sample.set_file_content(proto.file_content());
+    grpc::ByteBuffer wire_entry;
+    serializeEntry(sample, &wire_entry);
+    int calls = n * np;
+    std::cout << "[Bench] ReplicateEntry-Empfang, " << calls << " Aufrufe\n";
+    Result rc = measure([&] { receiveCopy(wire_entry, calls); });
+    Result rs = measure([&] { receiveShared(wire_entry, calls); });
+    print("receive copy", rc, calls);
+    print("receive shared", rs, calls);
+    printSaving(rc, rs, calls);
+  }
+
+  // GetUpdates über kUpdateEntries Einträge, Log wird außerhalb der Messung gebaut
+  std::vector<LogEntry> copy_log;
+  std::vector<EntryPtr> shared_log;
+  for (int i = 1; i <= kUpdateEntries; ++i) {
+    LogEntry e;
+    e.set_seq(i);
+    e.set_file_path(proto.file_path());
+    e.set_file_content(proto.file_content());
+    copy_log.push_back(e);
+    shared_log.push_back(std::make_shared<LogEntry>(e));
+  }
+  std::cout << "[Bench] GetUpdates mit " << kUpdateEntries << " Einträgen, "
+            << n << " Aufrufe\n";
+  Result uc = measure([&] { updatesCopy(copy_log, n); });
+  Result us = measure([&] { updatesShared(shared_log, n); });
+  print("updates copy", uc, n);
+  print("updates shared", us, n);
+  printSaving(uc, us, n);
+  return 0;
+}
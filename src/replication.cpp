@@ -0,0 +1,71 @@
+#include "replication.h"
+
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <google/protobuf/io/coded_stream.h>
+
+namespace dateisystem {
+
+using google::protobuf::Arena;
+using google::protobuf::io::CodedOutputStream;
+
+// UpdateResponse.entries: Feld 1, length-delimited
+static constexpr uint8_t kEntriesTag = (1 << 3) | 2;
+
+ArenaPtr newArena() {
+  return std::make_shared<Arena>();
+}
+
+EntryPtr makeWriteEntry(const ArenaPtr& arena, SyncRequest* req,
+                        int64_t seq, int64_t ts) {
+  auto* e = Arena::CreateMessage<LogEntry>(arena.get());
+  e->set_seq(seq);
+  e->set_timestamp(ts);
+  e->set_file_path(req->file_path());
+  e->mutable_file_content()->swap(*req->mutable_file_content());
+  e->set_is_delete(false);
+  return EntryPtr(arena, e);
+}
+
+EntryPtr makeDeleteEntry(const std::string& file_path, int64_t seq, int64_t ts) {
+  auto e = std::make_shared<LogEntry>();
+  e->set_seq(seq);
+  e->set_timestamp(ts);
+  e->set_file_path(file_path);
+  e->set_is_delete(true);
+  return e;
+}
+
+EntryPtr adoptEntry(const ArenaPtr& arena, const LogEntry* e) {
+  return EntryPtr(arena, e);
+}
+
+EntryPtr takeEntry(LogEntry* e) {
+  auto entry = std::make_shared<LogEntry>();
+  entry->Swap(e);
+  return entry;
+}
+
+grpc::Status serializeEntry(const LogEntry& e, grpc::ByteBuffer* out) {
+  bool own_buffer;
+  return grpc::SerializationTraits<LogEntry>::Serialize(e, out, &own_buffer);
+}
+
+size_t updatesWireSize(const std::vector<EntryPtr>& entries) {
+  size_t total = 0;
+  for (auto& e : entries) {
+    size_t n = e->ByteSizeLong();
+    total += 1 + CodedOutputStream::VarintSize64(n) + n;
+  }
+  return total;
+}
+
+void writeUpdates(const std::vector<EntryPtr>& entries, uint8_t* out) {
+  for (auto& e : entries) {
+    size_t n = e->ByteSizeLong();
+    *out++ = kEntriesTag;
+    out = CodedOutputStream::WriteVarint64ToArray(n, out);
+    out = e->SerializeWithCachedSizesToArray(out);
+  }
+}
+
+}  // namespace dateisystem
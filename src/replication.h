@@ -0,0 +1,49 @@
+#pragma once
+
+#include "./generated/dateisystem.pb.h"
+#include <grpcpp/support/byte_buffer.h>
+#include <google/protobuf/arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Gemeinsame Bausteine für den Replikationspfad (Server und bench_replication)
+namespace dateisystem {
+
+// Log-Einträge sind nach dem Anlegen unveränderlich und werden nur noch
+// geteilt (Log, Puffer, ausgehende RPCs) statt kopiert
+using EntryPtr = std::shared_ptr<const LogEntry>;
+
+// Arena eines Aufrufs. Einträge, die darin liegen, halten sie am Leben.
+using ArenaPtr = std::shared_ptr<google::protobuf::Arena>;
+
+ArenaPtr newArena();
+
+// Legt den Log-Eintrag für einen Schreibauftrag in arena an. file_content wird
+// per String-Swap aus req übernommen, req ist danach ohne Inhalt.
+EntryPtr makeWriteEntry(const ArenaPtr& arena, SyncRequest* req,
+                        int64_t seq, int64_t ts);
+
+EntryPtr makeDeleteEntry(const std::string& file_path, int64_t seq, int64_t ts);
+
+// Teilt einen Eintrag, der in arena liegt (z.B. ReplicateEntry-Request), ohne Kopie
+EntryPtr adoptEntry(const ArenaPtr& arena, const LogEntry* e);
+
+// Löst einen Eintrag aus einer eigenen Heap-Nachricht (z.B. UpdateResponse)
+// per Swap heraus; e ist danach leer
+EntryPtr takeEntry(LogEntry* e);
+
+// Serialisiert einen Eintrag einmal für alle Peers. Kopien des ByteBuffers
+// teilen sich die (refcounted) Slices.
+grpc::Status serializeEntry(const LogEntry& e, grpc::ByteBuffer* out);
+
+// UpdateResponse im Wire-Format direkt aus den geteilten Einträgen, damit
+// diese nie in eine veränderliche Nachricht eingehängt werden müssen.
+// out muss updatesWireSize(entries) Bytes fassen.
+size_t updatesWireSize(const std::vector<EntryPtr>& entries);
+void writeUpdates(const std::vector<EntryPtr>& entries, uint8_t* out);
+
+}  // namespace dateisystem
@@ -1,6 +1,11 @@
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/support/message_allocator.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpc/slice.h>
+#include <google/protobuf/arena.h>
 #include "./generated/dateisystem.pb.h"
 #include "./generated/dateisystem.grpc.pb.h"
+#include "replication.h"
 
 #include <iostream>
 #include <fstream>
@@ -8,16 +13,20 @@
 #include <mutex>
 #include <vector>
 #include <map>
+#include <memory>
 #include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <cstdlib>
 #include <system_error>
+#include <functional>
 
 using namespace dateisystem;
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
+using grpc::CallbackServerContext;
+using grpc::ServerUnaryReactor;
 using grpc::ClientContext;
 using grpc::Status;
 
@@ -28,8 +37,8 @@ static const std::filesystem::path DATA_DIR =
 // Globaler Zustand
 struct State {
   std::atomic<int64_t> next_seq{1};
-  std::vector<LogEntry> log;
-  std::map<int64_t, LogEntry> buffer;
+  std::vector<EntryPtr> log;
+  std::map<int64_t, EntryPtr> buffer;
   std::vector<std::string> peers;
   std::atomic<int64_t> clock_offset_ms{0};
   std::mutex mtx, peers_mtx;
@@ -50,14 +59,125 @@ static void snapshotDirectory(ListResponse* resp) {
   }
 }
 
+// Hilfsfunktion: wendet gepufferte Einträge lückenlos ab next_seq an
+static void applyBuffered(State& S) {
+  int64_t want = S.next_seq.load();
+  namespace fs = std::filesystem;
+  while (true) {
+    auto it = S.buffer.find(want);
+    if (it == S.buffer.end()) break;
+    const LogEntry& e = *it->second;
+    fs::path target = DATA_DIR / e.file_path();
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+    if (e.is_delete()) {
+      fs::remove(target, ec);
+    } else {
+      std::ofstream out(target, std::ios::binary);
+      out.write(e.file_content().data(), e.file_content().size());
+    }
+    S.log.push_back(std::move(it->second));
+    S.buffer.erase(it);
+    S.next_seq.fetch_add(1);
+    want++;
+  }
+}
+
+// Allocator für Callback-Methoden: Request und Response eines Aufrufs liegen
+// in einer eigenen Protobuf-Arena. Der Handler erhält über den Holder einen
+// veränderbaren Request; Log-Einträge, die in der Arena liegen, halten sie
+// über das Aufrufende hinaus am Leben.
+template <typename Req, typename Resp>
+class ArenaHolder final : public grpc::MessageHolder<Req, Resp> {
+  ArenaPtr arena_ = newArena();
+public:
+  ArenaHolder() {
+    this->set_request(google::protobuf::Arena::CreateMessage<Req>(arena_.get()));
+    this->set_response(google::protobuf::Arena::CreateMessage<Resp>(arena_.get()));
+  }
+  const ArenaPtr& arena() const { return arena_; }
+  void Release() override { delete this; }
+
+  static ArenaHolder* of(CallbackServerContext* ctx) {
+    return static_cast<ArenaHolder*>(ctx->GetRpcAllocatorState());
+  }
+};
+
+template <typename Req, typename Resp>
+class ArenaAllocator final : public grpc::MessageAllocator<Req, Resp> {
+public:
+  grpc::MessageHolder<Req, Resp>* AllocateMessages() override {
+    return new ArenaHolder<Req, Resp>();
+  }
+};
+
+// Hilfsfunktion: repliziert entry asynchron an alle Peers (Quorum = all).
+// Der Eintrag wird einmal serialisiert, alle Aufrufe senden denselben
+// ByteBuffer über den GenericStub. done(ok) läuft nach der letzten Antwort
+// auf einem gRPC-Thread.
+static const std::string kReplicateMethod = "/dateisystem.ReplicationService/ReplicateEntry";
+
+static void replicateToPeers(State& S, const LogEntry& entry, std::function<void(bool)> done) {
+  std::vector<std::string> peers;
+  { std::lock_guard<std::mutex> lk(S.peers_mtx); peers = S.peers; }
+  grpc::ByteBuffer wire;
+  if (!serializeEntry(entry, &wire).ok()) { done(false); return; }
+  if (peers.empty()) { done(true); return; }
+
+  struct Fanout {
+    std::atomic<size_t> pending;
+    std::atomic<size_t> acks{0};
+    size_t total;
+    std::function<void(bool)> done;
+  };
+  auto fan = std::make_shared<Fanout>();
+  fan->pending = peers.size();
+  fan->total = peers.size();
+  fan->done = std::move(done);
+
+  struct Call {
+    grpc::GenericStub stub;
+    ClientContext ctx;
+    grpc::ByteBuffer req, resp;
+    Call(const std::string& addr)
+      : stub(grpc::CreateChannel(addr, grpc::InsecureChannelCredentials())) {}
+  };
+  for (auto& addr : peers) {
+    auto* call = new Call(addr);
+    call->req = wire;  // teilt die Slices, keine Kopie der Payload
+    call->stub.UnaryCall(&call->ctx, kReplicateMethod, grpc::StubOptions(),
+                         &call->req, &call->resp, [call, fan](Status st) {
+      Ack ack;
+      if (st.ok() && grpc::SerializationTraits<Ack>::Deserialize(&call->resp, &ack).ok()
+          && ack.success())
+        fan->acks.fetch_add(1, std::memory_order_relaxed);
+      delete call;
+      if (fan->pending.fetch_sub(1) == 1)
+        fan->done(fan->acks.load() >= fan->total);
+    });
+  }
+}
+
 // PrimaryService: schreibt lokal und repliziert an alle Peers
-class PrimaryServiceImpl final : public PrimaryService::Service {
+// SyncFile/DeleteFile laufen über die Callback-API (Request in der Arena,
+// Replikation asynchron)
+class PrimaryServiceImpl final
+    : public PrimaryService::WithCallbackMethod_SyncFile<
+          PrimaryService::WithCallbackMethod_DeleteFile<PrimaryService::Service>> {
+  using SyncHolder = ArenaHolder<SyncRequest, SyncResponse>;
   State& S_;
+  ArenaAllocator<SyncRequest, SyncResponse> allocator_;
 public:
-  PrimaryServiceImpl(State& S) : S_(S) {}
+  PrimaryServiceImpl(State& S) : S_(S) {
+    SetMessageAllocatorFor_SyncFile(&allocator_);
+  }
 
-  Status SyncFile(ServerContext*, const SyncRequest* req, SyncResponse* resp) override {
+  ServerUnaryReactor* SyncFile(CallbackServerContext* ctx, const SyncRequest*,
+                               SyncResponse* resp) override {
     auto t_start = std::chrono::high_resolution_clock::now();
+    auto* reactor = ctx->DefaultReactor();
+    auto* holder = SyncHolder::of(ctx);
+    SyncRequest* req = holder->request();
     namespace fs = std::filesystem;
     // Zielpfad erzeugen
     fs::path target = DATA_DIR / req->file_path();
@@ -66,56 +186,42 @@ public:
     if (ec) {
       resp->set_success(false);
       resp->set_message("mkdir failed: " + ec.message());
-      return Status::OK;
+      reactor->Finish(Status::OK);
+      return reactor;
     }
     // Datei lokal schreiben
     {
       std::ofstream out(target, std::ios::binary);
       out.write(req->file_content().data(), req->file_content().size());
     }
-    // Log-Eintrag anlegen
+    // Log-Eintrag anlegen, Inhalt wird aus dem Request übernommen
     int64_t seq = S_.next_seq.fetch_add(1);
     int64_t ts  = std::chrono::duration_cast<std::chrono::milliseconds>(
                    std::chrono::system_clock::now().time_since_epoch()
                  ).count()
                  + S_.clock_offset_ms.load();
-    LogEntry entry;
-    entry.set_seq(seq);
-    entry.set_timestamp(ts);
-    entry.set_file_path(req->file_path());
-    entry.set_file_content(req->file_content());
-    entry.set_is_delete(false);
+    EntryPtr entry = makeWriteEntry(holder->arena(), req, seq, ts);
     {
       std::lock_guard<std::mutex> lk(S_.mtx);
       S_.log.push_back(entry);
     }
-    // Replikation an Peers (Quorum = all)
-    std::vector<std::string> peers;
-    { std::lock_guard<std::mutex> lk(S_.peers_mtx); peers = S_.peers; }
-    std::atomic<size_t> acks{0};
-    std::vector<std::thread> thr;
-    for (auto& addr : peers) {
-      thr.emplace_back([&, addr]() {
-        Ack ack; ClientContext ctx;
-        auto stub = ReplicationService::NewStub(
-          grpc::CreateChannel(addr, grpc::InsecureChannelCredentials()));
-        if (stub->ReplicateEntry(&ctx, entry, &ack).ok() && ack.success())
-          acks.fetch_add(1, std::memory_order_relaxed);
-      });
-    }
-    for (auto& t : thr) t.join();
-    auto t_end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
-    std::cout << "[Repl] Datei '" << req->file_path()
-              << "' repliziert in " << duration << " ms\n";
-
-    bool ok = (acks.load() >= peers.size());
-    resp->set_success(ok);
-    resp->set_message(ok ? "synced" : "replication error");
-    return Status::OK;
+    // Replikation an Peers (Quorum = all), asynchron über den Reactor
+    std::string path = req->file_path();
+    replicateToPeers(S_, *entry, [reactor, resp, t_start, path](bool ok) {
+      auto t_end = std::chrono::high_resolution_clock::now();
+      auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
+      std::cout << "[Repl] Datei '" << path
+                << "' repliziert in " << duration << " ms\n";
+      resp->set_success(ok);
+      resp->set_message(ok ? "synced" : "replication error");
+      reactor->Finish(Status::OK);
+    });
+    return reactor;
   }
 
-  Status DeleteFile(ServerContext*, const DeleteRequest* req, DeleteResponse* resp) override {
+  ServerUnaryReactor* DeleteFile(CallbackServerContext* ctx, const DeleteRequest* req,
+                                 DeleteResponse* resp) override {
+    auto* reactor = ctx->DefaultReactor();
     namespace fs = std::filesystem;
     // Datei löschen
     fs::path target = DATA_DIR / req->file_path();
@@ -124,7 +230,8 @@ public:
     if (ec) {
       resp->set_success(false);
       resp->set_message("remove failed: " + ec.message());
-      return Status::OK;
+      reactor->Finish(Status::OK);
+      return reactor;
     }
     // Log-Eintrag für Delete
     int64_t seq = S_.next_seq.fetch_add(1);
@@ -132,35 +239,18 @@ public:
                    std::chrono::system_clock::now().time_since_epoch()
                  ).count()
                  + S_.clock_offset_ms.load();
-    LogEntry entry;
-    entry.set_seq(seq);
-    entry.set_timestamp(ts);
-    entry.set_file_path(req->file_path());
-    entry.set_is_delete(true);
+    EntryPtr entry = makeDeleteEntry(req->file_path(), seq, ts);
     {
       std::lock_guard<std::mutex> lk(S_.mtx);
       S_.log.push_back(entry);
     }
     // Replikation an Peers
-    std::vector<std::string> peers;
-    { std::lock_guard<std::mutex> lk(S_.peers_mtx); peers = S_.peers; }
-    std::atomic<size_t> acks{0};
-    std::vector<std::thread> thr;
-    for (auto& addr : peers) {
-      thr.emplace_back([&, addr]() {
-        Ack ack; ClientContext ctx;
-        auto stub = ReplicationService::NewStub(
-          grpc::CreateChannel(addr, grpc::InsecureChannelCredentials()));
-        if (stub->ReplicateEntry(&ctx, entry, &ack).ok() && ack.success())
-          acks.fetch_add(1, std::memory_order_relaxed);
-      });
-    }
-    for (auto& t : thr) t.join();
-
-    bool ok = (acks.load() >= peers.size());
-    resp->set_success(ok);
-    resp->set_message(ok ? "deleted" : "del:replication error");
-    return Status::OK;
+    replicateToPeers(S_, *entry, [reactor, resp](bool ok) {
+      resp->set_success(ok);
+      resp->set_message(ok ? "deleted" : "del:replication error");
+      reactor->Finish(Status::OK);
+    });
+    return reactor;
   }
 
   Status ListFiles(ServerContext*, const ListRequest*, ListResponse* resp) override {
@@ -170,51 +260,65 @@ public:
 };
 
 // ReplicationService: verwendet LogEntry auf lokalen DATA_DIR an
-class ReplicationServiceImpl final : public ReplicationService::Service {
+// ReplicateEntry: Callback-API mit Arena-Allocator, der empfangene Eintrag
+// wird direkt aus der Arena geteilt.
+// GetUpdates: Raw-Callback, die Antwort wird aus den geteilten Einträgen in
+// einen ByteBuffer serialisiert, ohne sie in eine Nachricht einzuhängen.
+class ReplicationServiceImpl final
+    : public ReplicationService::WithCallbackMethod_ReplicateEntry<
+          ReplicationService::WithRawCallbackMethod_GetUpdates<ReplicationService::Service>> {
+  using EntryHolder = ArenaHolder<LogEntry, Ack>;
   State& S_;
+  ArenaAllocator<LogEntry, Ack> allocator_;
 public:
-  ReplicationServiceImpl(State& S) : S_(S) {}
-
-  Status ReplicateEntry(ServerContext*, const LogEntry* e, Ack* a) override {
-    std::lock_guard<std::mutex> lk(S_.mtx);
-    S_.buffer[e->seq()] = *e;
-    
-    std::cout << "[Slave] Empfange seq=" << e->seq()
-    << " @ " << std::chrono::duration_cast<std::chrono::milliseconds>(
-                 std::chrono::system_clock::now().time_since_epoch()).count()
-    << "\n";
-
-    int64_t want = S_.next_seq.load();
-    namespace fs = std::filesystem;
-    while (true) {
-      auto it = S_.buffer.find(want);
-      if (it == S_.buffer.end()) break;
-      fs::path target = DATA_DIR / it->second.file_path();
-      std::error_code ec;
-      fs::create_directories(target.parent_path(), ec);
-      if (it->second.is_delete()) {
-        fs::remove(target, ec);
-      } else {
-        std::ofstream out(target, std::ios::binary);
-        out.write(it->second.file_content().data(),
-                  it->second.file_content().size());
-      }
-      S_.log.push_back(it->second);
-      S_.buffer.erase(it);
-      S_.next_seq.fetch_add(1);
-      want++;
+  ReplicationServiceImpl(State& S) : S_(S) {
+    SetMessageAllocatorFor_ReplicateEntry(&allocator_);
+  }
+
+  ServerUnaryReactor* ReplicateEntry(CallbackServerContext* ctx, const LogEntry* e,
+                                     Ack* a) override {
+    EntryPtr entry = adoptEntry(EntryHolder::of(ctx)->arena(), e);
+    {
+      std::lock_guard<std::mutex> lk(S_.mtx);
+      S_.buffer[entry->seq()] = entry;
+
+      std::cout << "[Slave] Empfange seq=" << entry->seq()
+      << " @ " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count()
+      << "\n";
+
+      applyBuffered(S_);
     }
     a->set_success(true);
-    return Status::OK;
+    auto* reactor = ctx->DefaultReactor();
+    reactor->Finish(Status::OK);
+    return reactor;
   }
 
-  Status GetUpdates(ServerContext*, const UpdateRequest* req, UpdateResponse* resp) override {
-    std::lock_guard<std::mutex> lk(S_.mtx);
-    for (auto& e : S_.log) {
-      if (e.seq() >= req->from_seq())
-        *resp->add_entries() = e;
+  ServerUnaryReactor* GetUpdates(CallbackServerContext* ctx, const grpc::ByteBuffer* raw_req,
+                                 grpc::ByteBuffer* raw_resp) override {
+    auto* reactor = ctx->DefaultReactor();
+    UpdateRequest req;
+    grpc::ByteBuffer req_buf(*raw_req);
+    Status st = grpc::SerializationTraits<UpdateRequest>::Deserialize(&req_buf, &req);
+    if (!st.ok()) {
+      reactor->Finish(st);
+      return reactor;
     }
-    return Status::OK;
+    std::vector<EntryPtr> entries;
+    {
+      std::lock_guard<std::mutex> lk(S_.mtx);
+      for (auto& e : S_.log) {
+        if (e->seq() >= req.from_seq())
+          entries.push_back(e);
+      }
+    }
+    grpc_slice s = grpc_slice_malloc(updatesWireSize(entries));
+    writeUpdates(entries, GRPC_SLICE_START_PTR(s));
+    grpc::Slice slice(s, grpc::Slice::STEAL_REF);
+    *raw_resp = grpc::ByteBuffer(&slice, 1);
+    reactor->Finish(Status::OK);
+    return reactor;
   }
 };
 
@@ -326,30 +430,12 @@ int main(int argc, char** argv) {
         ClientContext ctx;
         if (stub->GetUpdates(&ctx, ur, &ursp).ok()) {
           std::lock_guard<std::mutex> lk(S.mtx);
-          for (auto& e : ursp.entries()) {
-            S.buffer[e.seq()] = e;
+          for (auto& e : *ursp.mutable_entries()) {
+            auto entry = takeEntry(&e);
+            S.buffer[entry->seq()] = std::move(entry);
           }
           // Sofort anwenden
-          int64_t want = S.next_seq.load();
-          namespace fs = std::filesystem;
-          while (true) {
-            auto it = S.buffer.find(want);
-            if (it == S.buffer.end()) break;
-            fs::path target = DATA_DIR / it->second.file_path();
-            std::error_code ec;
-            fs::create_directories(target.parent_path(), ec);
-            if (it->second.is_delete()) {
-              fs::remove(target, ec);
-            } else {
-              std::ofstream out(target, std::ios::binary);
-              out.write(it->second.file_content().data(),
-                        it->second.file_content().size());
-            }
-            S.log.push_back(it->second);
-            S.buffer.erase(it);
-            S.next_seq.fetch_add(1);
-            want++;
-          }
+          applyBuffered(S);
           std::cout << "[Startup Sync] " << ursp.entries_size()
                     << " Einträge vom Master übernommen.\n";
         } else {
@@ -410,8 +496,9 @@ int main(int argc, char** argv) {
         UpdateResponse ursp; ClientContext ctx;
         if (stub->GetUpdates(&ctx, ur, &ursp).ok()) {
           std::lock_guard<std::mutex> lk2(S.mtx);
-          for (auto& e : ursp.entries()) {
-            S.buffer[e.seq()] = e;
+          for (auto& e : *ursp.mutable_entries()) {
+            auto entry = takeEntry(&e);
+            S.buffer[entry->seq()] = std::move(entry);
           }
         }
       }